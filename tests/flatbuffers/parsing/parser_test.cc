@@ -4,6 +4,7 @@
 #include <optional>
 
 #include "tools/cpp/runfiles/runfiles.h"
+#include "utils/flatbuffer_builder_pool.h"
 #include "utils/wasmtime_runner.h"
 #include "tests/flatbuffers/parsing/message_generated.h"
 
@@ -18,23 +19,89 @@ TEST(FlatbuffersTest, ParsesMessage) {
     ASSERT_FALSE(parser_path.empty()) << "Could not find parser_bin";
 
     // 1. Create Flatbuffer message
-    flatbuffers::FlatBufferBuilder builder(1024);
+    utils::FlatBufferBuilderPool pool;
+    auto lease = pool.Acquire();
+    auto& builder = lease.builder();
     auto payload = builder.CreateString("Hello WASM");
     auto message = tests::parsing::CreateMessage(builder, payload);
     builder.Finish(message);
 
-    std::string input_data(
-        reinterpret_cast<const char*>(builder.GetBufferPointer()),
-        builder.GetSize()
-    );
-
     // 2. Run WASM
     auto runner_or_error = utils::WasmRunner::Create();
     ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
     auto& runner = runner_or_error.value();
 
-    auto result_or = runner.Run(parser_path, {"parser_bin"}, input_data);
+    auto result_or = runner.Run(parser_path, {"parser_bin"}, lease.AsStringView());
     
     ASSERT_TRUE(result_or.has_value()) << "Execution failed: " << result_or.error();
     EXPECT_EQ(result_or.value().stdout_output, "Hello WASM\n");
 }
+
+TEST(FlatbuffersTest, ReusesPooledBuilderAcrossMessages) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string parser_path = runfiles->Rlocation("wasm-bazel/tests/flatbuffers/parsing/parser_bin");
+    ASSERT_FALSE(parser_path.empty()) << "Could not find parser_bin";
+
+    auto runner_or_error = utils::WasmRunner::Create();
+    ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
+    auto& runner = runner_or_error.value();
+
+    utils::FlatBufferBuilderPool pool;
+    const uint8_t* first_buffer = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        auto lease = pool.Acquire();
+        std::string text = "Message " + std::to_string(i);
+        auto payload = lease->CreateString(text);
+        lease->Finish(tests::parsing::CreateMessage(lease.builder(), payload));
+
+        // The same builder (and its arena memory) is handed back every time
+        if (i == 0) first_buffer = lease->GetBufferPointer();
+        EXPECT_EQ(lease->GetBufferPointer(), first_buffer);
+
+        auto result_or = runner.Run(parser_path, {"parser_bin"}, lease.AsStringView());
+        ASSERT_TRUE(result_or.has_value()) << "Execution failed: " << result_or.error();
+        EXPECT_EQ(result_or.value().stdout_output, text + "\n");
+    }
+    EXPECT_EQ(pool.idle_count(), 1u);
+}
+
+TEST(FlatbuffersTest, RoundTripsLargeMessagesThroughPooledBuilder) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string parser_path = runfiles->Rlocation("wasm-bazel/tests/flatbuffers/parsing/parser_bin");
+    ASSERT_FALSE(parser_path.empty()) << "Could not find parser_bin";
+
+    auto runner_or_error = utils::WasmRunner::Create();
+    ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
+    auto& runner = runner_or_error.value();
+
+    // Payloads of several KiB force the builder well past its 1024 byte initial
+    // buffer, through both the arena's spill path and its in-place growth.
+    utils::FlatBufferBuilderPool pool;
+    const uint8_t* steady_buffer = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        auto lease = pool.Acquire();
+        std::string text(8 * 1024, static_cast<char>('a' + i));
+        auto payload = lease->CreateString(text);
+        lease->Finish(tests::parsing::CreateMessage(lease.builder(), payload));
+
+        // After the first message the arena has folded into one block that fits
+        if (i > 0) EXPECT_EQ(lease.allocator().block_count(), 1u);
+        if (i == 1) steady_buffer = lease->GetBufferPointer();
+
+        auto result_or = runner.Run(parser_path, {"parser_bin"}, lease.AsStringView());
+        ASSERT_TRUE(result_or.has_value()) << "Execution failed: " << result_or.error();
+        EXPECT_EQ(result_or.value().stdout_output, text + "\n");
+    }
+
+    // A same-sized message reuses exactly the same arena memory
+    auto lease = pool.Acquire();
+    std::string text(8 * 1024, 'z');
+    lease->Finish(tests::parsing::CreateMessage(lease.builder(), lease->CreateString(text)));
+    EXPECT_EQ(lease->GetBufferPointer(), steady_buffer);
+}
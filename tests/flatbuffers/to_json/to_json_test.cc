@@ -1,10 +1,15 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <string>
 #include <vector>
 #include <optional>
 #include <nlohmann/json.hpp>
+#include <unistd.h>
 
 #include "tools/cpp/runfiles/runfiles.h"
+#include "utils/flatbuffer_builder_pool.h"
 #include "utils/wasmtime_runner.h"
 #include "tests/flatbuffers/to_json/robot_generated.h"
 
@@ -20,7 +25,9 @@ TEST(ToJsonTest, ConvertsBinaryToJson) {
     ASSERT_FALSE(wasm_path.empty()) << "Could not find to_json_bin";
 
     // 1. Create Flatbuffer message
-    flatbuffers::FlatBufferBuilder builder(1024);
+    utils::FlatBufferBuilderPool pool;
+    auto lease = pool.Acquire();
+    auto& builder = lease.builder();
     auto name = builder.CreateString("Bender B. Rodriguez");
     
     tests::to_json::RobotBuilder robot_builder(builder);
@@ -31,17 +38,12 @@ TEST(ToJsonTest, ConvertsBinaryToJson) {
     
     builder.Finish(robot);
 
-    std::string input_data(
-        reinterpret_cast<const char*>(builder.GetBufferPointer()),
-        builder.GetSize()
-    );
-
     // 2. Run WASM
     auto runner_or_error = utils::WasmRunner::Create();
     ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
     auto& runner = runner_or_error.value();
 
-    auto result_or = runner.Run(wasm_path, {"to_json_bin"}, input_data);
+    auto result_or = runner.Run(wasm_path, {"to_json_bin"}, lease.AsStringView());
     
     ASSERT_TRUE(result_or.has_value()) << "Execution failed: " << result_or.error();
     std::string stdout_str = result_or.value().stdout_output;
@@ -57,3 +59,50 @@ TEST(ToJsonTest, ConvertsBinaryToJson) {
         FAIL() << "JSON parse error: " << e.what() << "\nOutput was: " << stdout_str;
     }
 }
+
+TEST(ToJsonTest, PerfMapProfilingNamesGuestFunctions) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string wasm_path = runfiles->Rlocation("wasm-bazel/tests/flatbuffers/to_json/to_json_bin");
+    ASSERT_FALSE(wasm_path.empty()) << "Could not find to_json_bin";
+
+    utils::FlatBufferBuilderPool pool;
+    auto lease = pool.Acquire();
+    auto name = lease->CreateString("Profiled");
+    tests::to_json::RobotBuilder robot_builder(lease.builder());
+    robot_builder.add_model_name(name);
+    lease->Finish(robot_builder.Finish());
+
+    // The perf map is shared by the whole process, so only remove it if this test
+    // created it and nobody is profiling the process from outside.
+    std::string map_path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+    bool keep_map = std::ifstream(map_path).good() || std::getenv("WASM_RUNNER_PROFILE") != nullptr;
+
+    utils::WasmRunnerOptions options;
+    options.profiling = utils::ProfilingMode::kPerfMap;
+    auto runner_or_error = utils::WasmRunner::Create(options);
+    ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
+    auto& runner = runner_or_error.value();
+
+    auto result_or = runner.Run(wasm_path, {"to_json_bin"}, lease.AsStringView());
+    ASSERT_TRUE(result_or.has_value()) << "Execution failed: " << result_or.error();
+
+    // wasmtime adds one line per compiled guest function, using its demangled
+    // name-section name; GenerateText is compiled into to_json_bin from flatbuffers.
+    std::ifstream map_file(map_path);
+    ASSERT_TRUE(map_file.is_open()) << "Missing perf map: " << map_path;
+    bool found = false;
+    std::string line;
+    while (std::getline(map_file, line)) {
+        if (line.find("GenerateText") != std::string::npos) {
+            found = true;
+            break;
+        }
+    }
+    map_file.close();
+    if (!keep_map) std::remove(map_path.c_str());
+
+    EXPECT_TRUE(found) << "No GenerateText entry in " << map_path;
+}
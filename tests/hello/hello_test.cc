@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "tools/cpp/runfiles/runfiles.h"
+#include "utils/wasmtime_async_runner.h"
 #include "utils/wasmtime_runner.h"
 
 using bazel::tools::cpp::runfiles::Runfiles;
@@ -44,3 +45,110 @@ TEST(HelloTest, ReturnsHelloName) {
     ASSERT_TRUE(result_or_error.has_value()) << "Execution failed: " << result_or_error.error();
     EXPECT_EQ(result_or_error.value().stdout_output, "Hello Test!\n");
 }
+
+// Polls a fresh run of hello_bin to completion and returns how many polls it took.
+int PollsToFinish(utils::AsyncWasmRunner& runner, const std::string& hello_path) {
+    auto run_or = runner.Start(hello_path, {"hello_bin"});
+    EXPECT_TRUE(run_or.has_value()) << "Start failed: " << run_or.error();
+    if (!run_or.has_value()) return -1;
+    auto& run = run_or.value();
+
+    int polls = 1;
+    while (!run->Poll()) ++polls;
+
+    auto result = run->TakeResult();
+    EXPECT_TRUE(result.has_value()) << "Execution failed: " << result.error();
+    return polls;
+}
+
+TEST(HelloTest, InterleavesAsyncRuns) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string hello_path = runfiles->Rlocation("wasm-bazel/tests/hello/hello_bin");
+    ASSERT_FALSE(hello_path.empty()) << "Could not find hello_bin";
+
+    // Small interval so each guest yields many times before finishing
+    utils::AsyncWasmRunnerOptions options;
+    options.yield_interval = 100;
+    auto runner_or_error = utils::AsyncWasmRunner::Create(options);
+    ASSERT_TRUE(runner_or_error.has_value()) << "Failed to create runner: " << runner_or_error.error();
+    auto& runner = runner_or_error.value();
+
+    auto first_or = runner.Start(hello_path, {"hello_bin", "First"});
+    ASSERT_TRUE(first_or.has_value()) << "Start failed: " << first_or.error();
+    auto second_or = runner.Start(hello_path, {"hello_bin", "Second"});
+    ASSERT_TRUE(second_or.has_value()) << "Start failed: " << second_or.error();
+    auto& first = first_or.value();
+    auto& second = second_or.value();
+
+    // After one round neither guest may have finished, otherwise nothing interleaved
+    first->Poll();
+    second->Poll();
+    EXPECT_FALSE(first->done());
+    EXPECT_FALSE(second->done());
+
+    while (!first->done() || !second->done()) {
+        first->Poll();
+        second->Poll();
+    }
+
+    auto first_result = first->TakeResult();
+    ASSERT_TRUE(first_result.has_value()) << "Execution failed: " << first_result.error();
+    EXPECT_EQ(first_result.value().stdout_output, "Hello First!\n");
+
+    auto second_result = second->TakeResult();
+    ASSERT_TRUE(second_result.has_value()) << "Execution failed: " << second_result.error();
+    EXPECT_EQ(second_result.value().stdout_output, "Hello Second!\n");
+}
+
+TEST(HelloTest, AsyncRunYieldsInsideStart) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string hello_path = runfiles->Rlocation("wasm-bazel/tests/hello/hello_bin");
+    ASSERT_FALSE(hello_path.empty()) << "Could not find hello_bin";
+
+    utils::AsyncWasmRunnerOptions fine;
+    fine.yield_interval = 100;
+    auto fine_runner = utils::AsyncWasmRunner::Create(fine);
+    ASSERT_TRUE(fine_runner.has_value()) << fine_runner.error();
+
+    utils::AsyncWasmRunnerOptions coarse;
+    coarse.yield_interval = uint64_t{1} << 60;
+    auto coarse_runner = utils::AsyncWasmRunner::Create(coarse);
+    ASSERT_TRUE(coarse_runner.has_value()) << coarse_runner.error();
+
+    // Without yielding a run takes exactly two polls: instantiate, then _start.
+    // Anything beyond that with the small interval must come from _start yielding.
+    int coarse_polls = PollsToFinish(coarse_runner.value(), hello_path);
+    int fine_polls = PollsToFinish(fine_runner.value(), hello_path);
+    EXPECT_EQ(coarse_polls, 2);
+    EXPECT_GT(fine_polls, coarse_polls + 10);
+}
+
+TEST(HelloTest, AsyncRunTrapsWhenFuelLimitIsExhausted) {
+    std::string error;
+    std::unique_ptr<Runfiles> runfiles(Runfiles::CreateForTest(&error));
+    ASSERT_NE(runfiles, nullptr) << "Failed to initialize runfiles: " << error;
+
+    std::string hello_path = runfiles->Rlocation("wasm-bazel/tests/hello/hello_bin");
+    ASSERT_FALSE(hello_path.empty()) << "Could not find hello_bin";
+
+    utils::AsyncWasmRunnerOptions options;
+    options.yield_interval = 100;
+    options.fuel_limit = 1000;
+    auto runner_or_error = utils::AsyncWasmRunner::Create(options);
+    ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
+
+    auto run_or = runner_or_error.value().Start(hello_path, {"hello_bin"});
+    ASSERT_TRUE(run_or.has_value()) << "Start failed: " << run_or.error();
+    auto& run = run_or.value();
+    while (!run->Poll()) {}
+
+    auto result = run->TakeResult();
+    ASSERT_FALSE(result.has_value()) << "Run unexpectedly succeeded";
+    EXPECT_NE(result.error().find("all fuel consumed"), std::string::npos) << result.error();
+}
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Profiles a host binary that runs wasm guests through utils::WasmRunner and
+# writes one collapsed-stack line ("root;...;leaf count") per unique stack,
+# ready for flamegraph.pl, inferno-flamegraph or speedscope.
+#
+# Guest frames show up under their demangled name-section names (e.g.
+# flatbuffers::GenerateText(...)); only functions without a name fall back to
+# wasm[<module>]::function[<index>].
+#
+# The profile covers the whole host process: host frames are included, and
+# every WasmRunner::Run in the process is merged into one profile. To profile a
+# single execution, narrow the binary down to one run (e.g. with --gtest_filter).
+#
+# Usage: profile_guest.sh <output.folded> <binary> [args...]
+# Example:
+#   bazel build //tests/flatbuffers/to_json:to_json_test
+#   tools/profiling/profile_guest.sh /tmp/to_json.folded \
+#       bazel-bin/tests/flatbuffers/to_json/to_json_test \
+#       --gtest_filter=ToJsonTest.ConvertsBinaryToJson
+#
+# Outside `bazel test`, gtest binaries need TEST_SRCDIR to find their runfiles;
+# it is set here from <binary>.runfiles when not already exported.
+
+set -euo pipefail
+
+if [[ $# -lt 2 ]]; then
+    echo "Usage: $0 <output.folded> <binary> [args...]" >&2
+    exit 1
+fi
+
+if ! command -v perf >/dev/null; then
+    echo "Error: perf not found in PATH" >&2
+    exit 1
+fi
+
+out="$1"
+shift
+
+if [[ -z "${TEST_SRCDIR:-}" && -d "$1.runfiles" ]]; then
+    TEST_SRCDIR="$(cd "$1.runfiles" && pwd)"
+    export TEST_SRCDIR
+fi
+
+data="$(mktemp /tmp/wasm_profile_XXXXXX)"
+trap 'rm -f "$data"' EXIT
+
+# perfmap lets perf resolve JIT-compiled guest functions via /tmp/perf-<pid>.map
+WASM_RUNNER_PROFILE=perfmap perf record -F "${PERF_FREQUENCY:-999}" -g -o "$data" -- "$@"
+
+# Sample headers start at column 0, frames are indented (leaf first) and a
+# blank line ends each sample.
+perf script -i "$data" | awk '
+    function flush() {
+        if (depth > 0) {
+            stack = frames[depth]
+            for (i = depth - 1; i >= 1; i--) stack = stack ";" frames[i]
+            counts[stack]++
+        }
+        depth = 0
+    }
+    /^[ \t]*$/ { flush(); next }
+    /^[^ \t]/ { flush(); next }
+    {
+        sym = $2
+        for (i = 3; i < NF; i++) sym = sym " " $i
+        sub(/\+0x[0-9a-f]+$/, "", sym)
+        gsub(/;/, ":", sym)
+        frames[++depth] = sym
+    }
+    END {
+        flush()
+        for (stack in counts) print stack, counts[stack]
+    }
+' > "$out"
+
+echo "Wrote $(wc -l < "$out") unique stacks to $out"
@@ -5,12 +5,18 @@
 #include <map>
 #include <uwebsockets/App.h>
 #include "tools/cpp/runfiles/runfiles.h"
+#include "tools/webserver/wasm_loop_driver.h"
+#include "utils/wasmtime_async_runner.h"
 
 namespace fs = std::filesystem;
 
 // Global runfiles object
 rules_cc::cc::runfiles::Runfiles* runfiles = nullptr;
 
+// Server-side guest execution, driven cooperatively from the uWS loop
+utils::AsyncWasmRunner* wasmRunner = nullptr;
+WasmLoopDriver* wasmDriver = nullptr;
+
 // MIME type mapping
 std::map<std::string, std::string> mimeTypes = {
     {".html", "text/html"},
@@ -103,6 +109,27 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Cap guest work per request so a runaway guest traps instead of spinning forever
+    utils::AsyncWasmRunnerOptions runnerOptions;
+    runnerOptions.fuel_limit = 100'000'000;
+    auto runnerOrError = utils::AsyncWasmRunner::Create(runnerOptions);
+    if (!runnerOrError.has_value()) {
+        std::cerr << "Error: Failed to create wasm runner: " << runnerOrError.error() << std::endl;
+        return 1;
+    }
+    wasmRunner = &runnerOrError.value();
+    
+    // Compile guests up front so requests never compile on the loop thread
+    std::string helloWasmPath = getRunfilesPath("/tests/hello/hello_bin");
+    if (!helloWasmPath.empty()) {
+        auto moduleOrError = wasmRunner->Load(helloWasmPath);
+        if (!moduleOrError.has_value()) {
+            std::cerr << "Warning: Failed to load hello guest: " << moduleOrError.error() << std::endl;
+        }
+    }
+    WasmLoopDriver driver(uWS::Loop::get());
+    wasmDriver = &driver;
+    
     std::cout << "Starting static file server..." << std::endl;
     std::cout << "Workspace: wasm-bazel" << std::endl;
     
@@ -116,6 +143,40 @@ int main(int argc, char* argv[]) {
             res->writeHeader("Access-Control-Max-Age", "86400"); // 24 hours
             res->end();
         })
+        .get("/api/hello/:name", [](auto *res, auto *req) {
+            // Runs the hello guest on the server without blocking other requests
+            std::string name = std::string(req->getParameter(0));
+            std::string wasmPath = getRunfilesPath("/tests/hello/hello_bin");
+            if (wasmPath.empty()) {
+                send404(res);
+                return;
+            }
+            
+            auto runOrError = wasmRunner->Start(wasmPath, {"hello_bin", name});
+            if (!runOrError.has_value()) {
+                send500(res, runOrError.error());
+                return;
+            }
+            
+            // The response is finished later from the loop. If the client goes away
+            // first, cancel the run so the guest stops consuming loop time.
+            auto runId = wasmDriver->Submit(std::move(runOrError.value()), [res](utils::Expected<utils::WasmResult> result) {
+                // Outside a uWS handler, so cork to send status, headers and body together
+                res->cork([res, &result]() {
+                    if (!result.has_value()) {
+                        send500(res, result.error());
+                        return;
+                    }
+                    res->writeStatus("200 OK");
+                    res->writeHeader("Content-Type", "text/plain");
+                    res->writeHeader("Access-Control-Allow-Origin", "*");
+                    res->end(result.value().stdout_output);
+                });
+            });
+            res->onAborted([runId]() {
+                wasmDriver->Cancel(runId);
+            });
+        })
         .get("/*", [](auto *res, auto *req) {
             std::string urlPath = std::string(req->getUrl());
             std::cout << "Request for: " << urlPath << std::endl;
@@ -0,0 +1,90 @@
+#ifndef TOOLS_WEBSERVER_WASM_LOOP_DRIVER_H_
+#define TOOLS_WEBSERVER_WASM_LOOP_DRIVER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <uwebsockets/Loop.h>
+
+#include "utils/wasmtime_async_runner.h"
+
+// Multiplexes in-flight wasm guests onto a uWS event loop.
+// Every loop iteration polls each run once (one fuel slice per guest), so
+// sockets keep being serviced between slices. Callbacks run on the loop thread.
+class WasmLoopDriver {
+public:
+    using Callback = std::function<void(utils::Expected<utils::WasmResult>)>;
+    using RunId = uint64_t;
+
+    explicit WasmLoopDriver(uWS::Loop* loop) : loop_(loop) {}
+
+    WasmLoopDriver(const WasmLoopDriver&) = delete;
+    WasmLoopDriver& operator=(const WasmLoopDriver&) = delete;
+
+    // The returned id can be passed to Cancel() while the run is in flight.
+    RunId Submit(std::unique_ptr<utils::PendingWasmRun> run, Callback on_done) {
+        RunId id = next_id_++;
+        runs_.push_back({id, std::move(run), std::move(on_done)});
+        Schedule();
+        return id;
+    }
+
+    // Drops the run, which cancels the guest; its callback is never invoked.
+    // Returns false if the run already finished or was cancelled.
+    bool Cancel(RunId id) {
+        for (size_t i = 0; i < runs_.size(); ++i) {
+            if (runs_[i].id != id) continue;
+            if (i + 1 != runs_.size()) runs_[i] = std::move(runs_.back());
+            runs_.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    size_t in_flight() const { return runs_.size(); }
+
+private:
+    struct Entry {
+        RunId id;
+        std::unique_ptr<utils::PendingWasmRun> run;
+        Callback on_done;
+    };
+
+    void Schedule() {
+        if (scheduled_) return;
+        scheduled_ = true;
+        loop_->defer([this]() { Tick(); });
+    }
+
+    void Tick() {
+        scheduled_ = false;
+
+        std::vector<Entry> finished;
+        for (size_t i = 0; i < runs_.size();) {
+            if (runs_[i].run->Poll()) {
+                finished.push_back(std::move(runs_[i]));
+                if (i + 1 != runs_.size()) runs_[i] = std::move(runs_.back());
+                runs_.pop_back();
+            } else {
+                ++i;
+            }
+        }
+
+        // Callbacks may Submit() more work, so only run them once runs_ is consistent
+        for (auto& entry : finished) {
+            entry.on_done(entry.run->TakeResult());
+        }
+
+        if (!runs_.empty()) Schedule();
+    }
+
+    uWS::Loop* loop_;
+    std::vector<Entry> runs_;
+    bool scheduled_ = false;
+    RunId next_id_ = 1;
+};
+
+#endif // TOOLS_WEBSERVER_WASM_LOOP_DRIVER_H_
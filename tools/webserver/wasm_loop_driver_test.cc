@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <uwebsockets/Loop.h>
+
+#include "tools/cpp/runfiles/runfiles.h"
+#include "tools/webserver/wasm_loop_driver.h"
+#include "utils/wasmtime_async_runner.h"
+
+using bazel::tools::cpp::runfiles::Runfiles;
+
+namespace {
+
+struct LoopWatch {
+    std::function<bool()> done;
+    int ticks_left;
+    bool timed_out = false;
+};
+
+// Runs the loop until done() holds, checking every millisecond. A live timer is
+// the only thing keeping us_loop_run going, so closing it ends the run.
+bool RunLoopUntil(uWS::Loop* loop, std::function<bool()> done, int timeout_ms = 10000) {
+    LoopWatch watch{std::move(done), timeout_ms};
+    us_timer_t* timer = us_create_timer((us_loop_t*) loop, 0, sizeof(LoopWatch*));
+    *(LoopWatch**) us_timer_ext(timer) = &watch;
+    us_timer_set(timer, [](us_timer_t* t) {
+        LoopWatch* w = *(LoopWatch**) us_timer_ext(t);
+        if (w->done()) {
+            us_timer_close(t);
+        } else if (--w->ticks_left <= 0) {
+            w->timed_out = true;
+            us_timer_close(t);
+        }
+    }, 1, 1);
+    loop->run();
+    return !watch.timed_out;
+}
+
+class WasmLoopDriverTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string error;
+        runfiles_.reset(Runfiles::CreateForTest(&error));
+        ASSERT_NE(runfiles_, nullptr) << "Failed to initialize runfiles: " << error;
+
+        hello_path_ = runfiles_->Rlocation("wasm-bazel/tests/hello/hello_bin");
+        ASSERT_FALSE(hello_path_.empty()) << "Could not find hello_bin";
+
+        utils::AsyncWasmRunnerOptions options;
+        options.yield_interval = 100;
+        auto runner_or_error = utils::AsyncWasmRunner::Create(options);
+        ASSERT_TRUE(runner_or_error.has_value()) << runner_or_error.error();
+        runner_ = std::make_unique<utils::AsyncWasmRunner>(std::move(runner_or_error.value()));
+    }
+
+    std::unique_ptr<utils::PendingWasmRun> StartHello(const std::string& name) {
+        auto run_or = runner_->Start(hello_path_, {"hello_bin", name});
+        EXPECT_TRUE(run_or.has_value()) << "Start failed: " << run_or.error();
+        return run_or.has_value() ? std::move(run_or.value()) : nullptr;
+    }
+
+    std::unique_ptr<Runfiles> runfiles_;
+    std::string hello_path_;
+    std::unique_ptr<utils::AsyncWasmRunner> runner_;
+};
+
+TEST_F(WasmLoopDriverTest, InvokesCallbacksWhenRunsComplete) {
+    WasmLoopDriver driver(uWS::Loop::get());
+
+    std::vector<std::string> outputs;
+    for (const char* name : {"First", "Second"}) {
+        auto run = StartHello(name);
+        ASSERT_NE(run, nullptr);
+        driver.Submit(std::move(run), [&outputs](utils::Expected<utils::WasmResult> result) {
+            ASSERT_TRUE(result.has_value()) << "Execution failed: " << result.error();
+            outputs.push_back(result.value().stdout_output);
+        });
+    }
+    EXPECT_EQ(driver.in_flight(), 2u);
+
+    ASSERT_TRUE(RunLoopUntil(uWS::Loop::get(), [&]() { return outputs.size() == 2; }));
+    EXPECT_EQ(driver.in_flight(), 0u);
+
+    // Completion order depends on scheduling, not submission order
+    std::sort(outputs.begin(), outputs.end());
+    EXPECT_EQ(outputs, (std::vector<std::string>{"Hello First!\n", "Hello Second!\n"}));
+}
+
+TEST_F(WasmLoopDriverTest, CancelSuppressesCallback) {
+    WasmLoopDriver driver(uWS::Loop::get());
+
+    auto cancelled_run = StartHello("Cancelled");
+    ASSERT_NE(cancelled_run, nullptr);
+    bool cancelled_called = false;
+    auto cancelled_id = driver.Submit(std::move(cancelled_run), [&](utils::Expected<utils::WasmResult>) {
+        cancelled_called = true;
+    });
+
+    auto kept_run = StartHello("Kept");
+    ASSERT_NE(kept_run, nullptr);
+    bool kept_called = false;
+    driver.Submit(std::move(kept_run), [&](utils::Expected<utils::WasmResult> result) {
+        EXPECT_TRUE(result.has_value()) << "Execution failed: " << result.error();
+        kept_called = true;
+    });
+
+    EXPECT_TRUE(driver.Cancel(cancelled_id));
+    EXPECT_EQ(driver.in_flight(), 1u);
+
+    ASSERT_TRUE(RunLoopUntil(uWS::Loop::get(), [&]() { return kept_called; }));
+    EXPECT_FALSE(cancelled_called);
+    EXPECT_EQ(driver.in_flight(), 0u);
+    EXPECT_FALSE(driver.Cancel(cancelled_id));
+}
+
+} // namespace
@@ -0,0 +1,201 @@
+#ifndef UTILS_FLATBUFFER_BUILDER_POOL_H_
+#define UTILS_FLATBUFFER_BUILDER_POOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace utils {
+
+// Bump allocator handing out memory from a small set of reusable blocks.
+// Only the most recent allocation in a block can be freed or grown in place,
+// which matches how FlatBufferBuilder's vector_downward uses its allocator.
+// When an allocation spills, blocks grow geometrically; Reset() then replaces
+// them with a single block sized to the largest allocation seen, so after one
+// cycle every grow stays inside that block (a memmove, no new heap memory).
+class ArenaAllocator : public flatbuffers::Allocator {
+public:
+    explicit ArenaAllocator(size_t block_size = 64 * 1024) : block_size_(block_size) {}
+
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    uint8_t* allocate(size_t size) override {
+        size_t aligned = Align(size);
+        peak_ = std::max(peak_, aligned);
+        for (; current_ < blocks_.size(); ++current_) {
+            Block& block = blocks_[current_];
+            if (block.size - block.used >= aligned) return Take(block, aligned);
+        }
+        size_t block_size = blocks_.empty() ? block_size_ : blocks_.back().size * 2;
+        AddBlock(std::max(block_size, aligned));
+        return Take(blocks_.back(), aligned);
+    }
+
+    void deallocate(uint8_t* p, size_t size) override {
+        // Only the newest allocation can be rewound; everything else waits for Reset().
+        if (current_ >= blocks_.size()) return;
+        Block& block = blocks_[current_];
+        if (block.used != 0 && p == block.data.get() + block.last) {
+            block.used = block.last;
+        }
+        (void)size;
+    }
+
+    uint8_t* reallocate_downward(uint8_t* old_p, size_t old_size, size_t new_size,
+                                 size_t in_use_back, size_t in_use_front) override {
+        if (current_ < blocks_.size()) {
+            Block& block = blocks_[current_];
+            size_t new_aligned = Align(new_size);
+            peak_ = std::max(peak_, new_aligned);
+            if (old_p == block.data.get() + block.last && block.size - block.last >= new_aligned) {
+                // Grow in place: the front (scratch) stays put, the back moves to the new end.
+                std::memmove(old_p + new_size - in_use_back, old_p + old_size - in_use_back, in_use_back);
+                block.used = block.last + new_aligned;
+                return old_p;
+            }
+        }
+        return flatbuffers::Allocator::reallocate_downward(old_p, old_size, new_size, in_use_back, in_use_front);
+    }
+
+    // Rewinds the arena. Any memory handed out before this call is invalid.
+    void Reset() {
+        if (blocks_.size() > 1) {
+            blocks_.clear();
+            AddBlock(std::max(block_size_, peak_));
+        }
+        for (auto& block : blocks_) {
+            block.used = 0;
+            block.last = 0;
+        }
+        current_ = 0;
+    }
+
+    size_t block_count() const { return blocks_.size(); }
+
+private:
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+        size_t used;
+        size_t last;  // Offset of the most recent allocation
+    };
+
+    static size_t Align(size_t size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+    void AddBlock(size_t size) {
+        blocks_.push_back(Block{std::make_unique<uint8_t[]>(size), size, 0, 0});
+        current_ = blocks_.size() - 1;
+    }
+
+    static uint8_t* Take(Block& block, size_t aligned) {
+        block.last = block.used;
+        block.used += aligned;
+        return block.data.get() + block.last;
+    }
+
+    size_t block_size_;
+    size_t peak_ = 0;  // Largest single allocation, including in-place grows
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+};
+
+// Pool of FlatBufferBuilders, each backed by its own ArenaAllocator.
+// Returning a lease resets the builder (dropping its buffer) and rewinds the
+// arena. Each message still starts at initial_size and grows by memmove within
+// the arena block, but once a builder has seen its largest message, building
+// further messages does no heap allocation. Not thread-safe.
+class FlatBufferBuilderPool {
+    struct Entry {
+        explicit Entry(size_t initial_size)
+            : allocator(initial_size * 2), builder(initial_size, &allocator, false) {}
+        ArenaAllocator allocator;
+        flatbuffers::FlatBufferBuilder builder;
+    };
+
+public:
+    // Do not call builder().Release() or ReleaseRaw() on a leased builder: the
+    // returned memory belongs to the arena and is reused once the lease is returned.
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool_(other.pool_), entry_(std::move(other.entry_)) {
+            other.pool_ = nullptr;
+        }
+
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                Release();
+                pool_ = other.pool_;
+                entry_ = std::move(other.entry_);
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() { Release(); }
+
+        flatbuffers::FlatBufferBuilder& builder() { return entry_->builder; }
+        flatbuffers::FlatBufferBuilder* operator->() { return &entry_->builder; }
+        const ArenaAllocator& allocator() const { return entry_->allocator; }
+
+        // View of the finished buffer, valid until the next Clear() or until the lease is released.
+        std::string_view AsStringView() const {
+            return std::string_view(reinterpret_cast<const char*>(entry_->builder.GetBufferPointer()),
+                                    entry_->builder.GetSize());
+        }
+
+    private:
+        friend class FlatBufferBuilderPool;
+        Lease(FlatBufferBuilderPool* pool, std::unique_ptr<Entry> entry)
+            : pool_(pool), entry_(std::move(entry)) {}
+
+        void Release() {
+            if (pool_ && entry_) pool_->Return(std::move(entry_));
+            pool_ = nullptr;
+        }
+
+        FlatBufferBuilderPool* pool_;
+        std::unique_ptr<Entry> entry_;
+    };
+
+    explicit FlatBufferBuilderPool(size_t initial_size = 1024) : initial_size_(initial_size) {}
+
+    FlatBufferBuilderPool(const FlatBufferBuilderPool&) = delete;
+    FlatBufferBuilderPool& operator=(const FlatBufferBuilderPool&) = delete;
+
+    // The pool must outlive every lease it hands out.
+    Lease Acquire() {
+        if (free_.empty()) return Lease(this, std::make_unique<Entry>(initial_size_));
+        std::unique_ptr<Entry> entry = std::move(free_.back());
+        free_.pop_back();
+        return Lease(this, std::move(entry));
+    }
+
+    size_t idle_count() const { return free_.size(); }
+
+private:
+    void Return(std::unique_ptr<Entry> entry) {
+        entry->builder.Reset();
+        entry->allocator.Reset();
+        free_.push_back(std::move(entry));
+    }
+
+    size_t initial_size_;
+    std::vector<std::unique_ptr<Entry>> free_;
+};
+
+} // namespace utils
+
+#endif // UTILS_FLATBUFFER_BUILDER_POOL_H_
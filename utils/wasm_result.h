@@ -0,0 +1,45 @@
+#ifndef UTILS_WASM_RESULT_H_
+#define UTILS_WASM_RESULT_H_
+
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace utils {
+
+struct WasmResult {
+    std::string stdout_output;
+    std::string stderr_output;
+    int exit_code = 0;
+};
+
+// Simple Expected shim since we can't rely on std::expected (C++23)
+struct Unexpected {
+    std::string error;
+};
+
+template <typename T>
+class Expected {
+public:
+    Expected(T value) : value_(std::move(value)), has_value_(true) {}
+    Expected(Unexpected u) : error_(std::move(u.error)), has_value_(false) {}
+    // Allow implicit conversion from char* for convenience if strictly error? No, might confuse.
+    // Keep it explicit.
+
+    bool has_value() const { return has_value_; }
+    const T& value() const { return *value_; }
+    T& value() { return *value_; } // Non-const accessor
+    const std::string& error() const { return error_; }
+
+private:
+    std::optional<T> value_;
+    std::string error_;
+    bool has_value_;
+};
+
+// Specialization or requirement: T must be default constructible for this simple shim
+// if we don't use union/variant. WasmRunner is movable, pointers are easy.
+
+} // namespace utils
+
+#endif // UTILS_WASM_RESULT_H_
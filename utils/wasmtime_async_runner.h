@@ -0,0 +1,267 @@
+#ifndef UTILS_WASMTIME_ASYNC_RUNNER_H_
+#define UTILS_WASMTIME_ASYNC_RUNNER_H_
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "wasmtime.h"
+#include "utils/wasm_result.h"
+#include "utils/wasmtime_internal.h"
+#include "utils/wasmtime_runner.h"
+
+namespace utils {
+
+// One in-flight guest execution started by AsyncWasmRunner::Start.
+// Each run owns its own store, so any number of them can be interleaved on one
+// thread. Poll() resumes the guest until it next yields (every yield_interval
+// units of fuel) or finishes; it never blocks for the whole execution.
+// Destroying an unfinished run cancels the guest.
+class PendingWasmRun {
+public:
+    // Pinned in place: the in-flight wasmtime future writes into trap_/error_.
+    PendingWasmRun(const PendingWasmRun&) = delete;
+    PendingWasmRun& operator=(const PendingWasmRun&) = delete;
+
+    ~PendingWasmRun() {
+        // The future borrows the store, so it has to go first. Dropping an
+        // unfinished future cancels the guest.
+        if (future_) wasmtime_call_future_delete(future_);
+        if (trap_) wasm_trap_delete(trap_);
+        if (error_) wasmtime_error_delete(error_);
+        if (module_) wasmtime_module_delete(module_);
+        if (store_) wasmtime_store_delete(store_);
+    }
+
+    // Returns true once the run has finished and TakeResult() may be called.
+    bool Poll() {
+        if (result_.has_value()) return true;
+        if (!wasmtime_call_future_poll(future_)) return false;
+
+        wasmtime_call_future_delete(future_);
+        future_ = nullptr;
+
+        if (error_ || trap_) {
+            // HandleError takes ownership of both
+            Finish(internal::HandleError(error_, trap_, &stdout_file_, &stderr_file_));
+            error_ = nullptr;
+            trap_ = nullptr;
+            return true;
+        }
+
+        if (stage_ == Stage::kInstantiating) {
+            wasmtime_module_delete(module_);
+            module_ = nullptr;
+
+            if (!wasmtime_instance_export_get(context_, &instance_, "_start", 6, &start_func_) ||
+                start_func_.kind != WASMTIME_EXTERN_FUNC) {
+                Finish(Expected<WasmResult>(Unexpected{"_start function not found"}));
+                return true;
+            }
+
+            stage_ = Stage::kRunning;
+            future_ = wasmtime_func_call_async(context_, &start_func_.of.func, nullptr, 0, nullptr, 0, &trap_, &error_);
+            return false;
+        }
+
+        Finish(internal::ReadOutputs(stdout_file_, stderr_file_));
+        return true;
+    }
+
+    bool done() const { return result_.has_value(); }
+
+    // Only valid after Poll() has returned true.
+    Expected<WasmResult> TakeResult() { return std::move(*result_); }
+
+private:
+    friend class AsyncWasmRunner;
+
+    enum class Stage { kInstantiating, kRunning };
+
+    PendingWasmRun(wasmtime_store_t* store, internal::TempUtilsFile stdout_file, internal::TempUtilsFile stderr_file)
+        : store_(store), context_(wasmtime_store_context(store)),
+          stdout_file_(std::move(stdout_file)), stderr_file_(std::move(stderr_file)) {}
+
+    void Finish(Expected<WasmResult> result) {
+        result_.emplace(std::move(result));
+        // Release the store and its linear memory as soon as the guest is done
+        if (store_) {
+            wasmtime_store_delete(store_);
+            store_ = nullptr;
+            context_ = nullptr;
+        }
+    }
+
+    Stage stage_ = Stage::kInstantiating;
+    wasmtime_store_t* store_;
+    wasmtime_context_t* context_;
+    wasmtime_module_t* module_ = nullptr;  // Our own reference, dropped after instantiation
+    wasmtime_instance_t instance_;
+    wasmtime_extern_t start_func_;
+    wasmtime_call_future_t* future_ = nullptr;
+    wasm_trap_t* trap_ = nullptr;
+    wasmtime_error_t* error_ = nullptr;
+    internal::TempUtilsFile stdout_file_;
+    internal::TempUtilsFile stderr_file_;
+    std::optional<Expected<WasmResult>> result_;
+};
+
+struct AsyncWasmRunnerOptions {
+    // Fuel between yields back to the caller; smaller means finer interleaving
+    uint64_t yield_interval = 10000;
+    // Total fuel per run before the guest traps. Server-side callers should set
+    // this so a guest that never exits cannot occupy the loop forever.
+    uint64_t fuel_limit = std::numeric_limits<uint64_t>::max();
+    // Engine settings shared with WasmRunner, e.g. profiling. When unset,
+    // Create() reads them from the environment once.
+    std::optional<WasmRunnerOptions> runner;
+};
+
+// Async counterpart of WasmRunner for use inside an event loop.
+// Uses wasmtime's async support with fuel-based yielding: a guest hands control
+// back to the caller every yield_interval units of fuel (roughly wasm
+// instructions), so long-running guests never stall the loop. Compiled modules
+// and the WASI linker are cached per runner; call Load() ahead of time (e.g. at
+// server startup) so Start() never compiles on the loop thread.
+class AsyncWasmRunner {
+public:
+    // Move-only
+    AsyncWasmRunner(AsyncWasmRunner&& other) noexcept
+        : engine_(other.engine_), linker_(other.linker_), options_(other.options_),
+          modules_(std::move(other.modules_)) {
+        other.engine_ = nullptr;
+        other.linker_ = nullptr;
+        other.modules_.clear();
+    }
+
+    AsyncWasmRunner& operator=(AsyncWasmRunner&& other) noexcept {
+        if (this != &other) {
+            Cleanup();
+            engine_ = other.engine_;
+            linker_ = other.linker_;
+            options_ = other.options_;
+            modules_ = std::move(other.modules_);
+            other.engine_ = nullptr;
+            other.linker_ = nullptr;
+            other.modules_.clear();
+        }
+        return *this;
+    }
+
+    AsyncWasmRunner(const AsyncWasmRunner&) = delete;
+    AsyncWasmRunner& operator=(const AsyncWasmRunner&) = delete;
+
+    ~AsyncWasmRunner() {
+        Cleanup();
+    }
+
+    static Expected<AsyncWasmRunner> Create(const AsyncWasmRunnerOptions& options = {}) {
+        wasm_config_t* config = wasm_config_new();
+        if (!config) return Expected<AsyncWasmRunner>(Unexpected{"Failed to create config"});
+        wasmtime_config_async_support_set(config, true);
+        wasmtime_config_consume_fuel_set(config, true);
+
+        WasmRunnerOptions runner_options = options.runner.has_value() ? *options.runner : WasmRunnerOptions::FromEnv();
+        wasm_engine_t* engine = internal::NewEngine(config, runner_options);
+        if (!engine) return Expected<AsyncWasmRunner>(Unexpected{"Failed to create engine"});
+
+        // One WASI linker serves every store created from this engine
+        wasmtime_linker_t* linker = wasmtime_linker_new(engine);
+        wasmtime_error_t* error = wasmtime_linker_define_wasi(linker);
+        if (error) {
+            wasmtime_linker_delete(linker);
+            wasm_engine_delete(engine);
+            return Expected<AsyncWasmRunner>(Unexpected{internal::FormatError(error)});
+        }
+
+        return Expected<AsyncWasmRunner>(AsyncWasmRunner(engine, linker, options));
+    }
+
+    // Reads and compiles the module at wasm_path unless it is already cached.
+    // The returned module is owned by the runner.
+    Expected<wasmtime_module_t*> Load(const std::string& wasm_path) {
+        auto it = modules_.find(wasm_path);
+        if (it != modules_.end()) return Expected<wasmtime_module_t*>(it->second);
+
+        auto wasm_data_or = internal::ReadFile(wasm_path);
+        if (!wasm_data_or.has_value()) return Expected<wasmtime_module_t*>(Unexpected{wasm_data_or.error()});
+        const std::string& wasm_data = wasm_data_or.value();
+
+        wasmtime_module_t* module = nullptr;
+        wasmtime_error_t* error = wasmtime_module_new(engine_, (const uint8_t*)wasm_data.data(), wasm_data.size(), &module);
+        if (error) return Expected<wasmtime_module_t*>(Unexpected{internal::FormatError(error)});
+
+        modules_.emplace(wasm_path, module);
+        return Expected<wasmtime_module_t*>(module);
+    }
+
+    // Begins instantiating the module (compiling it first only if it was never
+    // loaded); the guest makes no progress until the returned run is polled.
+    // The runner must outlive every run it starts.
+    Expected<std::unique_ptr<PendingWasmRun>> Start(const std::string& wasm_path, const std::vector<std::string>& args, std::optional<std::string_view> stdin_content = std::nullopt) {
+        using Result = Expected<std::unique_ptr<PendingWasmRun>>;
+
+        auto module_or = Load(wasm_path);
+        if (!module_or.has_value()) return Result(Unexpected{module_or.error()});
+
+        wasmtime_store_t* store = wasmtime_store_new(engine_, nullptr, nullptr);
+        if (!store) return Result(Unexpected{"Failed to create store"});
+        wasmtime_context_t* context = wasmtime_store_context(store);
+
+        wasmtime_error_t* error = wasmtime_context_set_fuel(context, options_.fuel_limit);
+        if (!error) error = wasmtime_context_fuel_async_yield_interval(context, options_.yield_interval);
+        if (error) {
+            wasmtime_store_delete(store);
+            return Result(Unexpected{internal::FormatError(error)});
+        }
+
+        auto files_or = internal::ConfigureWasi(context, args, stdin_content);
+        if (!files_or.has_value()) {
+            wasmtime_store_delete(store);
+            return Result(Unexpected{files_or.error()});
+        }
+
+        // From here on the run owns the store
+        std::unique_ptr<PendingWasmRun> run(new PendingWasmRun(
+            store, std::move(files_or.value().stdout_file), std::move(files_or.value().stderr_file)));
+
+        // The run holds its own module reference so it stays valid during
+        // instantiation; the shared linker lives as long as the runner.
+        run->module_ = wasmtime_module_clone(module_or.value());
+        run->future_ = wasmtime_linker_instantiate_async(linker_, run->context_, run->module_,
+                                                         &run->instance_, &run->trap_, &run->error_);
+        return Result(std::move(run));
+    }
+
+private:
+    AsyncWasmRunner(wasm_engine_t* engine, wasmtime_linker_t* linker, const AsyncWasmRunnerOptions& options)
+        : engine_(engine), linker_(linker), options_(options) {}
+
+    void Cleanup() {
+        for (auto& [path, module] : modules_) wasmtime_module_delete(module);
+        modules_.clear();
+        if (linker_) {
+            wasmtime_linker_delete(linker_);
+            linker_ = nullptr;
+        }
+        if (engine_) {
+            wasm_engine_delete(engine_);
+            engine_ = nullptr;
+        }
+    }
+
+    wasm_engine_t* engine_;
+    wasmtime_linker_t* linker_;
+    AsyncWasmRunnerOptions options_;
+    std::map<std::string, wasmtime_module_t*> modules_;
+};
+
+} // namespace utils
+
+#endif // UTILS_WASMTIME_ASYNC_RUNNER_H_
@@ -0,0 +1,163 @@
+#ifndef UTILS_WASMTIME_INTERNAL_H_
+#define UTILS_WASMTIME_INTERNAL_H_
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "wasmtime.h"
+#include "utils/wasm_result.h"
+
+// WASI plumbing and error formatting shared by WasmRunner and AsyncWasmRunner.
+// Not part of the public API.
+namespace utils::internal {
+
+inline Expected<std::string> ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return Expected<std::string>(Unexpected{"Open failed: " + path});
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return Expected<std::string>(buffer.str());
+}
+
+// Temp file holding one guest output stream, removed on destruction
+class TempUtilsFile {
+public:
+    // Use static create instead of constructor to avoid exceptions
+    static Expected<TempUtilsFile> Create() {
+         char template_path[] = "/tmp/wasm_runner_XXXXXX";
+         int fd = mkstemp(template_path);
+         if (fd == -1) return Expected<TempUtilsFile>(Unexpected{"mkstemp failed"});
+         close(fd);
+         return Expected<TempUtilsFile>(TempUtilsFile(template_path));
+    }
+
+    TempUtilsFile(TempUtilsFile&& other) noexcept : path_(std::move(other.path_)) {
+        other.path_.clear(); // Prevent weak state
+    }
+    
+    TempUtilsFile& operator=(TempUtilsFile&& other) noexcept {
+        if (this != &other) {
+            if (!path_.empty()) std::remove(path_.c_str());
+            path_ = std::move(other.path_);
+            other.path_.clear();
+        }
+        return *this;
+    }
+
+    ~TempUtilsFile() { if (!path_.empty()) std::remove(path_.c_str()); }
+    const std::string& path() const { return path_; }
+    
+    Expected<std::string> ReadContent() const { return ReadFile(path_); }
+
+private:
+    TempUtilsFile(std::string path) : path_(std::move(path)) {}
+    std::string path_;
+};
+
+inline std::string FormatError(wasmtime_error_t* error, wasm_trap_t* trap = nullptr) {
+    std::string err_msg;
+    if (trap) {
+         wasm_message_t message;
+         wasm_trap_message(trap, &message);
+         err_msg = "Trap: " + std::string(message.data, message.size);
+         wasm_byte_vec_delete(&message);
+         wasm_trap_delete(trap);
+    }
+    if (error) {
+        wasm_message_t message;
+        wasmtime_error_message(error, &message);
+        if (!err_msg.empty()) err_msg += " | ";
+        err_msg += "Error: " + std::string(message.data, message.size);
+        wasm_byte_vec_delete(&message);
+        wasmtime_error_delete(error);
+    }
+    return err_msg;
+}
+
+inline Expected<WasmResult> HandleError(wasmtime_error_t* error, wasm_trap_t* trap = nullptr, const TempUtilsFile* stdout_file = nullptr, const TempUtilsFile* stderr_file = nullptr) {
+    std::string infra_error = FormatError(error, trap);
+    std::string output_info;
+    
+    if (stdout_file) {
+         auto stdout_res = stdout_file->ReadContent();
+         if (stdout_res.has_value() && !stdout_res.value().empty()) {
+             output_info += "\nSTDOUT:\n" + stdout_res.value();
+         }
+    }
+    if (stderr_file) {
+         auto stderr_res = stderr_file->ReadContent();
+         if (stderr_res.has_value() && !stderr_res.value().empty()) {
+             output_info += "\nSTDERR:\n" + stderr_res.value();
+         }
+    }
+    return Expected<WasmResult>(Unexpected{infra_error + output_info});
+}
+
+struct WasiFiles {
+    TempUtilsFile stdout_file;
+    TempUtilsFile stderr_file;
+};
+
+// Builds a fresh WASI config for one run and installs it on the context,
+// overwriting any previous one. Guest stdout/stderr go to the returned temp files.
+inline Expected<WasiFiles> ConfigureWasi(wasmtime_context_t* context, const std::vector<std::string>& args, std::optional<std::string_view> stdin_content) {
+    auto stdout_file_or = TempUtilsFile::Create();
+    if (!stdout_file_or.has_value()) return Expected<WasiFiles>(Unexpected{"Stdout temp file creation failed: " + stdout_file_or.error()});
+    auto stderr_file_or = TempUtilsFile::Create();
+    if (!stderr_file_or.has_value()) return Expected<WasiFiles>(Unexpected{"Stderr temp file creation failed: " + stderr_file_or.error()});
+    WasiFiles files{std::move(stdout_file_or.value()), std::move(stderr_file_or.value())};
+
+    wasi_config_t* wasi = wasi_config_new();
+
+    std::vector<const char*> argv_ptrs;
+    for (const auto& arg : args) {
+        argv_ptrs.push_back(arg.c_str());
+    }
+    wasi_config_set_argv(wasi, argv_ptrs.size(), argv_ptrs.data());
+    wasi_config_inherit_env(wasi);
+
+    if (stdin_content.has_value()) {
+        wasm_byte_vec_t stdin_vec;
+        wasm_byte_vec_new(&stdin_vec, stdin_content->size(), stdin_content->data());
+        wasi_config_set_stdin_bytes(wasi, &stdin_vec);
+    }
+
+    if (!wasi_config_set_stdout_file(wasi, files.stdout_file.path().c_str())) {
+         wasi_config_delete(wasi);
+         return Expected<WasiFiles>(Unexpected{"Failed to set stdout file"});
+    }
+    if (!wasi_config_set_stderr_file(wasi, files.stderr_file.path().c_str())) {
+         wasi_config_delete(wasi);
+         return Expected<WasiFiles>(Unexpected{"Failed to set stderr file"});
+    }
+
+    // Takes ownership of the config, even on failure
+    wasmtime_error_t* error = wasmtime_context_set_wasi(context, wasi);
+    if (error) return Expected<WasiFiles>(Unexpected{FormatError(error)});
+
+    return Expected<WasiFiles>(std::move(files));
+}
+
+inline Expected<WasmResult> ReadOutputs(const TempUtilsFile& stdout_file, const TempUtilsFile& stderr_file) {
+    WasmResult result;
+    auto stdout_res = stdout_file.ReadContent();
+    if (!stdout_res.has_value()) return Expected<WasmResult>(Unexpected{"Failed to read stdout: " + stdout_res.error()});
+    result.stdout_output = std::move(stdout_res.value());
+
+    auto stderr_res = stderr_file.ReadContent();
+    if (!stderr_res.has_value()) return Expected<WasmResult>(Unexpected{"Failed to read stderr: " + stderr_res.error()});
+    result.stderr_output = std::move(stderr_res.value());
+
+    return Expected<WasmResult>(result);
+}
+
+} // namespace utils::internal
+
+#endif // UTILS_WASMTIME_INTERNAL_H_